@@ -0,0 +1,79 @@
+/**
+ * @file context.c
+ * @brief Implements the front-end context for the Thale programming language.
+ *
+ * This file provides the default allocator and diagnostics sink installed
+ * by initContext(), and the helpers that route allocations through a
+ * context.
+ *
+ * @author Codezz-ops <codezz-ops@protonmail.com>
+ *
+ * @copyright Copyright (c) 2025 Codezz-ops
+ */
+
+#include <stdlib.h>
+#include "context.h"
+
+/**
+ * @brief Default allocator backed by malloc().
+ *
+ * @param userData Unused.
+ * @param size Number of bytes to allocate.
+ * @return void* The allocated block, or NULL on failure.
+ */
+static void *defaultAlloc(void *userData, size_t size)
+{
+    (void)userData;
+    return malloc(size);
+}
+
+/**
+ * @brief Default release function backed by free().
+ *
+ * @param userData Unused.
+ * @param ptr The block to release.
+ */
+static void defaultRelease(void *userData, void *ptr)
+{
+    (void)userData;
+    free(ptr);
+}
+
+/**
+ * @brief Initializes a context with the default allocator and diagnostics.
+ *
+ * @param ctx Pointer to the context to initialize.
+ */
+void initContext(ThaleContext *ctx)
+{
+    ctx->alloc = defaultAlloc;
+    ctx->release = defaultRelease;
+    ctx->allocData = NULL;
+    ctx->diagnostic = printDiagnostic;
+    ctx->diagnosticData = NULL;
+    ctx->errorCount = 0;
+}
+
+/**
+ * @brief Allocates memory through the context's allocator.
+ *
+ * @param ctx Pointer to the context.
+ * @param size Number of bytes to allocate.
+ * @return void* The allocated block, or NULL on failure.
+ */
+void *contextAlloc(ThaleContext *ctx, size_t size)
+{
+    return ctx->alloc(ctx->allocData, size);
+}
+
+/**
+ * @brief Releases memory obtained from contextAlloc().
+ *
+ * @param ctx Pointer to the context.
+ * @param ptr The block to release; NULL is ignored.
+ */
+void contextFree(ThaleContext *ctx, void *ptr)
+{
+    if (ptr)
+        ctx->release(ctx->allocData, ptr);
+}
@@ -12,9 +12,7 @@
  */
 
 #include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include "error.h"
+#include "context.h"
 
 /**
  * @brief Converts an ErrorType enum to a string representation.
@@ -41,44 +39,52 @@ const char *errorTypeToString(ErrorType type)
  * @brief Prints an error message to stderr with context information.
  *
  * This function formats and displays an error message, including the type of error,
- * the line and column where the error occurred, and a snippet of the source code
- * around the error. It also handles color formatting for terminal output based on
- * the operating system.
+ * the file (when known), line and column where the error occurred, and the source
+ * line containing it.
  *
- * @param type The type of error that occurred.
- * @param message A message describing the error.
- * @param lex A pointer to the Lexer structure.
- * @param token A pointer to the Token structure that contains information about
- *              the location of the error in the source code.
+ * @param userData Unused.
+ * @param diagnostic The error being reported.
  * @return void.
  */
-void reportError(ErrorType type, const char *message, const Lex *lex, const Token *token)
+void printDiagnostic(void *userData, const Diagnostic *diagnostic)
 {
-    const char *src = lex->start;
-    const char *line_start = token->start;
-    while (line_start > src && line_start[-1] != '\n')
-        line_start--;
+    (void)userData;
 
-    const char *line_end = token->start;
-    while (*line_end != '\n' && *line_end != '\0')
-        line_end++;
+    const SourcePosition *pos = &diagnostic->position;
 
-    int column = (int)(token->start - line_start) + 1;
-
-    fprintf(stderr, "%s: [line %d, column %d] %s",
-            errorTypeToString(type),
-            token->line,
-            column,
-            message);
+    if (pos->file)
+        fprintf(stderr, "%s: [%s, line %d, column %d] %s",
+                errorTypeToString(diagnostic->type),
+                pos->file->path,
+                pos->line,
+                pos->column,
+                diagnostic->message);
+    else
+        fprintf(stderr, "%s: [line %d, column %d] %s",
+                errorTypeToString(diagnostic->type),
+                pos->line,
+                pos->column,
+                diagnostic->message);
 
     fputc('\n', stderr);
 
-    fprintf(stderr, "    %d | %.*s\n", token->line, (int)(line_end - line_start), line_start);
+    fprintf(stderr, "    %d | %.*s\n", pos->line, diagnostic->lineLength, diagnostic->lineStart);
 
     fputs("      | ", stderr);
-    for (int i = 1; i < column; i++)
+    for (int i = 1; i < pos->column; i++)
         fputc(' ', stderr);
     fputs("^\n", stderr);
+}
 
-    exit(EXIT_FAILURE);
+/**
+ * @brief Records an error in the context and dispatches it.
+ *
+ * @param ctx Pointer to the context that receives the error.
+ * @param diagnostic The error being reported.
+ * @return void.
+ */
+void reportError(ThaleContext *ctx, const Diagnostic *diagnostic)
+{
+    ctx->errorCount++;
+    ctx->diagnostic(ctx->diagnosticData, diagnostic);
 }
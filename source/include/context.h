@@ -0,0 +1,73 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+/**
+ * @file context.h
+ * @brief Defines the front-end context shared by every stage of the Thale compiler.
+ *
+ * This header file provides the ThaleContext structure, which carries the
+ * allocator and diagnostics sink used by the lexer and error reporting, so
+ * that several independent front ends can run in one process.
+ *
+ * @author Codezz-ops <codezz-ops@protonmail.com>
+ *
+ * @copyright Copyright (c) 2025 Codezz-ops
+ */
+
+#include <stddef.h>
+#include "error.h"
+
+/**
+ * @typedef DiagnosticHandler
+ * @brief Function pointer type for receiving reported errors.
+ *
+ * Handlers must return; the reporting stage recovers and continues.
+ */
+typedef void (*DiagnosticHandler)(void *userData, const Diagnostic *diagnostic);
+
+/**
+ * @struct ThaleContext
+ * @brief Holds the per-embedding state of the front end.
+ *
+ * The allocator callbacks receive `allocData` and the diagnostic handler
+ * receives `diagnosticData`, so each can be backed by its own state. The
+ * context counts reported errors so callers can decide whether to continue
+ * after a stage completes.
+ */
+typedef struct ThaleContext
+{
+    void *(*alloc)(void *userData, size_t size);
+    void (*release)(void *userData, void *ptr);
+    void *allocData;
+    DiagnosticHandler diagnostic;
+    void *diagnosticData;
+    int errorCount;
+} ThaleContext;
+
+/**
+ * @brief Initializes a context with the default allocator and diagnostics.
+ *
+ * The defaults use malloc/free and print diagnostics to stderr.
+ *
+ * @param ctx Pointer to the context to initialize.
+ */
+void initContext(ThaleContext *ctx);
+
+/**
+ * @brief Allocates memory through the context's allocator.
+ *
+ * @param ctx Pointer to the context.
+ * @param size Number of bytes to allocate.
+ * @return void* The allocated block, or NULL on failure.
+ */
+void *contextAlloc(ThaleContext *ctx, size_t size);
+
+/**
+ * @brief Releases memory obtained from contextAlloc().
+ *
+ * @param ctx Pointer to the context.
+ * @param ptr The block to release; NULL is ignored.
+ */
+void contextFree(ThaleContext *ctx, void *ptr);
+
+#endif // CONTEXT_H
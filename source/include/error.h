@@ -14,7 +14,9 @@
  * @copyright Copyright (c) 2025 Codezz-ops
  */
 
-#include "lex.h"
+#include "source.h"
+
+struct ThaleContext;
 
 /**
  * @enum ErrorType
@@ -42,17 +44,47 @@ typedef enum
 const char *errorTypeToString(ErrorType type);
 
 /**
- * @brief Reports an error with a specific message and token information.
+ * @struct Diagnostic
+ * @brief A reported error, independent of the stage that found it.
+ *
+ * `position` is resolved from `loc`; its `file` is NULL when the source was
+ * not registered with a source manager. `lineStart` and `lineLength`
+ * delimit the source line containing the error, for excerpts. `message`
+ * and `lineStart` are only valid for the duration of the handler call;
+ * a handler that keeps a diagnostic must copy the text it needs.
+ */
+typedef struct
+{
+    ErrorType type;
+    const char *message;
+    SourceLoc loc;
+    SourcePosition position;
+    const char *lineStart;
+    int lineLength;
+} Diagnostic;
+
+/**
+ * @brief Reports an error through a context.
+ *
+ * This function counts the error in the context and forwards it to the
+ * context's diagnostic handler. It returns to the caller, which is
+ * expected to recover and continue.
+ *
+ * @param ctx Pointer to the context that receives the error.
+ * @param diagnostic The error being reported.
+ * @return void.
+ */
+void reportError(struct ThaleContext *ctx, const Diagnostic *diagnostic);
+
+/**
+ * @brief Prints an error with a source excerpt to stderr.
  *
- * This function handles error reporting by displaying the error message and
- * associated token information.
+ * This is the default diagnostic handler installed by initContext().
  *
- * @param type The type of error being reported.
- * @param message The error message to display.
- * @param lex Pointer to the lexer.
- * @param token Pointer to the token associated with the error (if applicable).
+ * @param userData Unused.
+ * @param diagnostic The error being reported.
  * @return void.
  */
-void reportError(ErrorType type, const char *message, const Lex *lex, const Token *token);
+void printDiagnostic(void *userData, const Diagnostic *diagnostic);
 
 #endif // ERROR_H
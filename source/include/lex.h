@@ -14,7 +14,11 @@
  * @copyright Copyright (c) 2025 Codezz-ops
  */
 
+#include <stdbool.h>
 #include <stddef.h>
+#include "source.h"
+
+struct ThaleContext;
 
 /**
  * @enum TokenType
@@ -78,51 +82,105 @@ typedef enum
  * @brief Represents a token recognized by the lexer.
  *
  * This structure holds information about a token, including its type,
- * the starting position in the source code, its length, and its line
- * and column numbers.
+ * the starting position in the source code, its length, and its location
+ * in the source manager's location space. Line and column are recovered
+ * from the location only when they are needed.
  */
 typedef struct
 {
     TokenType typ;
     char *start;
-    int length, line, column;
+    int length;
+    SourceLoc loc;
 } Token;
 
+/**
+ * @brief Capacity of the lexer's token ring.
+ *
+ * Must be a power of two. peekToken() can see at most LEX_LOOKAHEAD - 1
+ * tokens beyond the next one, and lexRewind() avoids re-lexing as long as
+ * no more than LEX_LOOKAHEAD tokens have been lexed since the mark.
+ */
+#define LEX_LOOKAHEAD 16
+
+/**
+ * @struct LexSlot
+ * @brief A token held in the lexer's ring, with the scan pointer before it.
+ *
+ * The saved position lets a mark taken while tokens are buffered describe
+ * where scanning must resume if the ring no longer holds them.
+ */
+typedef struct
+{
+    Token token;
+    char *current;
+} LexSlot;
+
 /**
  * @struct Lex
  * @brief Represents the lexer state.
  *
  * This structure holds the current state of the lexer, including the
- * current position in the source code and the line and column numbers.
+ * current position in the source code, the file being lexed (NULL for a
+ * bare buffer) and the location of its first byte. Scanned tokens pass
+ * through a fixed-size ring; `head` counts tokens returned by
+ * getNextToken() and `tail` counts tokens scanned, so `tail - head`
+ * tokens of lookahead are buffered. Ring entries below `floor` are stale
+ * after a rewind, and `scanned` is the highest token count ever reached,
+ * so tokens below it are re-scans and stay silent. `errorLine` and
+ * `errorLineNumber` cache the start and number of the last line an error
+ * was reported on, so bare buffers without a line table are not rescanned
+ * from the beginning for every error.
  */
 typedef struct
 {
+    struct ThaleContext *ctx;
+    const SourceFile *file;
     char *start, *current;
-    int line, column;
+    SourceLoc base;
+    char *errorLine;
+    int errorLineNumber;
+    LexSlot ring[LEX_LOOKAHEAD];
+    unsigned int head, tail, floor, scanned;
 } Lex;
 
 /**
- * @struct KeywordEntry
- * @brief Represents a keyword entry for the lexer.
+ * @struct LexMark
+ * @brief A checkpoint in the token stream returned by lexMark().
  *
- * This structure holds a keyword and its corresponding token type.
+ * Records the index of the next token to be returned and the scan position
+ * from which that token can be lexed again.
  */
 typedef struct
 {
-    const char *keyword;
-    TokenType token;
-} KeywordEntry;
+    char *current;
+    unsigned int index;
+} LexMark;
 
 /**
  * @brief Initializes the lexer with the source code.
  *
- * This function sets the starting position, current position, line number,
- * and column number for the lexer based on the provided source code.
+ * This function sets the starting and current position for the lexer based
+ * on the provided source code. Token locations are byte offsets into
+ * `source`. Errors found while lexing are reported through `ctx`.
  *
  * @param lex Pointer to the lexer instance to initialize.
+ * @param ctx Pointer to the context that receives diagnostics.
  * @param source Pointer to the source code string.
+ * @return bool false if `source` is NULL, true otherwise.
+ */
+bool initLex(Lex *lex, struct ThaleContext *ctx, char *source);
+
+/**
+ * @brief Initializes the lexer over a file registered with a source manager.
+ *
+ * Token locations fall in the file's range of the global location space.
+ *
+ * @param lex Pointer to the lexer instance to initialize.
+ * @param ctx Pointer to the context that receives diagnostics.
+ * @param file The registered file to tokenize.
  */
-void initLex(Lex *lex, char *source);
+void initLexFile(Lex *lex, struct ThaleContext *ctx, const SourceFile *file);
 
 /**
  * @brief Retrieves the next token from the lexer.
@@ -135,4 +193,38 @@ void initLex(Lex *lex, char *source);
  */
 Token getNextToken(Lex *lex);
 
+/**
+ * @brief Returns an upcoming token without consuming it.
+ *
+ * `n` is the distance from the next token: peekToken(lex, 0) returns the
+ * token the next getNextToken() call will return. The ring cannot hold
+ * tokens at a distance of LEX_LOOKAHEAD or more, so such requests return
+ * an Unknown token of length zero.
+ *
+ * @param lex Pointer to the lexer instance.
+ * @param n How many tokens past the next one to look.
+ * @return Token The token `n` positions ahead.
+ */
+Token peekToken(Lex *lex, unsigned int n);
+
+/**
+ * @brief Records the current position in the token stream.
+ *
+ * @param lex Pointer to the lexer instance.
+ * @return LexMark A checkpoint that can be passed to lexRewind().
+ */
+LexMark lexMark(const Lex *lex);
+
+/**
+ * @brief Returns the lexer to a previously recorded checkpoint.
+ *
+ * Runs in constant time. Tokens still held in the ring are replayed
+ * without being lexed again; otherwise scanning resumes from the position
+ * saved in the mark. Errors in re-scanned tokens are not reported again.
+ *
+ * @param lex Pointer to the lexer instance.
+ * @param mark A checkpoint previously returned by lexMark() for this lexer.
+ */
+void lexRewind(Lex *lex, LexMark mark);
+
 #endif // LEX_H
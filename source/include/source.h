@@ -0,0 +1,135 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+/**
+ * @file source.h
+ * @brief Defines the source manager for the Thale compiler.
+ *
+ * This header file provides the structures and functions used to register
+ * source files, place each one in a single 32-bit location space, and map
+ * a location back to its file, line and column.
+ *
+ * @author Codezz-ops <codezz-ops@protonmail.com>
+ *
+ * @copyright Copyright (c) 2025 Codezz-ops
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct ThaleContext;
+
+/**
+ * @typedef SourceLoc
+ * @brief A position in the global location space of a SourceManager.
+ */
+typedef uint32_t SourceLoc;
+
+/**
+ * @struct SourceFile
+ * @brief A registered source file.
+ *
+ * The file owns a NUL-terminated copy of its text and occupies the
+ * locations `base` through `base + length` inclusive, the last one being
+ * the end-of-file position. `lines` holds the offset of each line start.
+ */
+typedef struct
+{
+    char *path, *text;
+    SourceLoc base;
+    uint32_t length, lineCount;
+    uint32_t *lines;
+} SourceFile;
+
+/**
+ * @struct SourcePosition
+ * @brief A location resolved to a file, line and column.
+ *
+ * `file` is NULL when the location does not belong to any registered file.
+ */
+typedef struct
+{
+    const SourceFile *file;
+    int line, column;
+} SourcePosition;
+
+/**
+ * @struct SourceManager
+ * @brief Owns every registered source file, in increasing location order.
+ */
+typedef struct SourceManager
+{
+    struct ThaleContext *ctx;
+    SourceFile **files;
+    uint32_t count, capacity;
+    SourceLoc nextBase;
+} SourceManager;
+
+/**
+ * @brief Initializes an empty source manager.
+ *
+ * @param sm Pointer to the source manager to initialize.
+ * @param ctx Pointer to the context whose allocator is used.
+ */
+void initSourceManager(SourceManager *sm, struct ThaleContext *ctx);
+
+/**
+ * @brief Releases every file registered with the source manager.
+ *
+ * @param sm Pointer to the source manager.
+ */
+void freeSourceManager(SourceManager *sm);
+
+/**
+ * @brief Reads a file from disk and registers it.
+ *
+ * @param sm Pointer to the source manager.
+ * @param path Path of the file to read.
+ * @return const SourceFile* The registered file, or NULL if it could not be
+ *         read, allocated, or does not fit in the location space.
+ */
+const SourceFile *addSourceFile(SourceManager *sm, const char *path);
+
+/**
+ * @brief Registers an in-memory buffer as a source file.
+ *
+ * The text is copied, so the caller's buffer need not outlive the manager.
+ *
+ * @param sm Pointer to the source manager.
+ * @param name Name used for the file in diagnostics.
+ * @param text The source text.
+ * @param length Length of `text` in bytes.
+ * @return const SourceFile* The registered file, or NULL on failure.
+ */
+const SourceFile *addSourceBuffer(SourceManager *sm, const char *name, const char *text, size_t length);
+
+/**
+ * @brief Finds the file that contains a location.
+ *
+ * @param sm Pointer to the source manager.
+ * @param loc The location to look up.
+ * @return const SourceFile* The containing file, or NULL if none.
+ */
+const SourceFile *findSourceFile(const SourceManager *sm, SourceLoc loc);
+
+/**
+ * @brief Maps a location to a line and column within a known file.
+ *
+ * @param file The file containing `loc`.
+ * @param loc The location to resolve.
+ * @return SourcePosition The 1-based line and column of `loc`.
+ */
+SourcePosition resolveFileLocation(const SourceFile *file, SourceLoc loc);
+
+/**
+ * @brief Maps a location to its file, line and column.
+ *
+ * @param sm Pointer to the source manager.
+ * @param loc The location to resolve.
+ * @return SourcePosition The resolved position; `file` is NULL if `loc` is
+ *         outside every registered file.
+ */
+SourcePosition resolveLocation(const SourceManager *sm, SourceLoc loc);
+
+#endif // SOURCE_H
@@ -12,24 +12,33 @@
  */
 
 #include <ctype.h>
-#include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
-#include "error.h"
+#include "context.h"
+#include "lex.h"
 
 /**
- * @brief Array of keywords recognized by the lexer.
+ * @brief Compares the remainder of a candidate against a single keyword.
  *
- * Each entry maps a string keyword to its corresponding TokenType.
+ * Called once the length and leading character have already selected the
+ * only keyword the identifier could be.
+ *
+ * @param start Pointer to the beginning of the identifier string.
+ * @param length Length of the identifier string (equal to the keyword's).
+ * @param keyword The keyword spelling to compare against.
+ * @param type The token type to return on a match.
+ * @return TokenType The keyword token type, or Identifier on mismatch.
  */
-static const KeywordEntry kw[] = {
-    {"Char", Char}, {"False", False}, {"Float", Float}, {"Int", Int}, {"let", Let}, {"List", List}, {"match", Match}, {"True", True}, {"type", Type}, {"Unit", Unit}, {"with", With}, {"String", String}, {"effect", Effect}};
+static inline TokenType checkRest(const char *start, size_t length, const char *keyword, TokenType type)
+{
+    return memcmp(start + 1, keyword + 1, length - 1) == 0 ? type : Identifier;
+}
 
 /**
  * @brief Checks if a given identifier matches a reserved keyword.
  *
- * Compares the input string with the known keyword list and returns
- * the corresponding TokenType if a match is found, otherwise returns Identifier.
+ * Dispatches on the identifier length and then on its first character, so
+ * at most one keyword is compared per identifier instead of scanning the
+ * whole keyword list.
  *
  * @param start Pointer to the beginning of the identifier string.
  * @param length Length of the identifier string.
@@ -37,12 +46,54 @@ static const KeywordEntry kw[] = {
  */
 static TokenType checkKeyword(const char *start, size_t length)
 {
-    for (size_t i = 0; i < sizeof(kw) / sizeof(kw[0]); i++)
+    switch (length)
     {
-        const KeywordEntry *entry = &kw[i];
-        if (strlen(entry->keyword) == length &&
-            strncmp(entry->keyword, start, length) == 0)
-            return entry->token;
+    case 3:
+        switch (start[0])
+        {
+        case 'I':
+            return checkRest(start, length, "Int", Int);
+        case 'l':
+            return checkRest(start, length, "let", Let);
+        }
+        break;
+    case 4:
+        switch (start[0])
+        {
+        case 'C':
+            return checkRest(start, length, "Char", Char);
+        case 'L':
+            return checkRest(start, length, "List", List);
+        case 'T':
+            return checkRest(start, length, "True", True);
+        case 't':
+            return checkRest(start, length, "type", Type);
+        case 'U':
+            return checkRest(start, length, "Unit", Unit);
+        case 'w':
+            return checkRest(start, length, "with", With);
+        }
+        break;
+    case 5:
+        switch (start[0])
+        {
+        case 'F':
+            if (start[1] == 'a')
+                return checkRest(start, length, "False", False);
+            return checkRest(start, length, "Float", Float);
+        case 'm':
+            return checkRest(start, length, "match", Match);
+        }
+        break;
+    case 6:
+        switch (start[0])
+        {
+        case 'S':
+            return checkRest(start, length, "String", String);
+        case 'e':
+            return checkRest(start, length, "effect", Effect);
+        }
+        break;
     }
     return Identifier;
 }
@@ -50,19 +101,44 @@ static TokenType checkKeyword(const char *start, size_t length)
 /**
  * @brief Initializes the lexer state.
  *
- * Sets the starting position, current position, line, and column of the lexer.
+ * Sets the starting and current position of the lexer. Locations are byte
+ * offsets into `source`.
  *
  * @param lex Pointer to the lexer to initialize.
+ * @param ctx Pointer to the context that receives diagnostics.
  * @param source The source code string to tokenize.
+ * @return bool false if `source` is NULL, true otherwise.
  */
-void initLex(Lex *lex, char *source)
+bool initLex(Lex *lex, ThaleContext *ctx, char *source)
 {
     if (!source)
-        exit(EXIT_FAILURE);
+        return false;
+    lex->ctx = ctx;
+    lex->file = NULL;
     lex->start = source;
     lex->current = source;
-    lex->line = 1;
-    lex->column = 1;
+    lex->base = 0;
+    lex->errorLine = source;
+    lex->errorLineNumber = 1;
+    lex->head = 0;
+    lex->tail = 0;
+    lex->floor = 0;
+    lex->scanned = 0;
+    return true;
+}
+
+/**
+ * @brief Initializes the lexer over a registered source file.
+ *
+ * @param lex Pointer to the lexer to initialize.
+ * @param ctx Pointer to the context that receives diagnostics.
+ * @param file The file to tokenize.
+ */
+void initLexFile(Lex *lex, ThaleContext *ctx, const SourceFile *file)
+{
+    initLex(lex, ctx, file->text);
+    lex->file = file;
+    lex->base = file->base;
 }
 
 /**
@@ -71,42 +147,25 @@ void initLex(Lex *lex, char *source)
  * Advances the lexer's current pointer past spaces, tabs, newlines,
  * and single-line comments starting with "--".
  *
- * @param lex The lexer to advance.
- * @return Lex The updated lexer state after skipping whitespace.
+ * @param lex Pointer to the lexer to advance.
  */
-static Lex skipWhiteSpace(Lex lex)
+static void skipWhiteSpace(Lex *lex)
 {
     for (;;)
     {
-        while (isspace((unsigned char)*lex.current))
-        {
-            if (*lex.current == '\n')
-            {
-                lex.line++;
-                lex.column = 1;
-            }
-            else
-            {
-                lex.column++;
-            }
-            lex.current++;
-        }
+        while (isspace((unsigned char)*lex->current))
+            lex->current++;
 
-        if (lex.current[0] == '-' && lex.current[1] == '-')
+        if (lex->current[0] == '-' && lex->current[1] == '-')
         {
-            lex.current += 2;
-            lex.column += 2;
-            while (*lex.current && *lex.current != '\n')
-            {
-                lex.current++;
-                lex.column++;
-            }
+            lex->current += 2;
+            while (*lex->current && *lex->current != '\n')
+                lex->current++;
             continue;
         }
 
         break;
     }
-    return lex;
 }
 
 /**
@@ -114,17 +173,78 @@ static Lex skipWhiteSpace(Lex lex)
  *
  * @param type The type of the token.
  * @param start Pointer to the start of the token in the source code.
- * @param lex Current state of the lexer.
+ * @param lex Pointer to the current lexer state.
  * @return Token The newly created token.
  */
-static inline Token makeToken(TokenType type, char *start, Lex lex)
+static inline Token makeToken(TokenType type, char *start, const Lex *lex)
 {
     return (Token){
         .typ = type,
         .start = start,
-        .length = (int)(lex.current - start),
-        .line = lex.line,
-        .column = lex.column};
+        .length = (int)(lex->current - start),
+        .loc = lex->base + (SourceLoc)(start - lex->start)};
+}
+
+/**
+ * @brief Reports a lexical error unless the token is being re-scanned.
+ *
+ * After a rewind past the ring, tokens already seen are lexed a second
+ * time; their errors were reported on the first pass. The position and
+ * line excerpt come from the file's line table when one is set. For a bare
+ * buffer, newlines are counted forward from the line of the previous
+ * error, since errors are reported in source order.
+ *
+ * @param message The error message.
+ * @param lex Pointer to the lexer.
+ * @param token The offending token.
+ */
+static void lexError(const char *message, Lex *lex, const Token *token)
+{
+    if (lex->tail < lex->scanned)
+        return;
+
+    SourcePosition position;
+    const char *lineStart, *lineEnd;
+    const SourceFile *file = lex->file;
+
+    if (file)
+    {
+        position = resolveFileLocation(file, token->loc);
+        uint32_t line = (uint32_t)position.line;
+        lineStart = file->text + file->lines[line - 1];
+        lineEnd = line < file->lineCount ? file->text + file->lines[line] - 1
+                                         : file->text + file->length;
+    }
+    else
+    {
+        if (token->start < lex->errorLine)
+        {
+            lex->errorLine = lex->start;
+            lex->errorLineNumber = 1;
+        }
+
+        char *newline;
+        while ((newline = memchr(lex->errorLine, '\n', (size_t)(token->start - lex->errorLine))) != NULL)
+        {
+            lex->errorLine = newline + 1;
+            lex->errorLineNumber++;
+        }
+
+        lineStart = lex->errorLine;
+        lineEnd = lineStart + strcspn(lineStart, "\n");
+        position.file = NULL;
+        position.line = lex->errorLineNumber;
+        position.column = (int)(token->start - lineStart) + 1;
+    }
+
+    Diagnostic diagnostic = {
+        .type = LexicalError,
+        .message = message,
+        .loc = token->loc,
+        .position = position,
+        .lineStart = lineStart,
+        .lineLength = (int)(lineEnd - lineStart)};
+    reportError(lex->ctx, &diagnostic);
 }
 
 /**
@@ -140,12 +260,9 @@ static Token parseIdentifier(Lex *lex)
 {
     char *start = lex->current - 1;
     while (isalnum((unsigned char)*lex->current) || *lex->current == '_')
-    {
         lex->current++;
-        lex->column++;
-    }
     TokenType type = checkKeyword(start, (size_t)(lex->current - start));
-    return makeToken(type, start, *lex);
+    return makeToken(type, start, lex);
 }
 
 /**
@@ -158,25 +275,18 @@ static Token parseNumber(Lex *lex)
 {
     char *start = lex->current - 1;
     while (isdigit((unsigned char)*lex->current))
-    {
         lex->current++;
-        lex->column++;
-    }
 
     TokenType type = IntLiteral;
     if (*lex->current == '.')
     {
         lex->current++;
-        lex->column++;
         while (isdigit((unsigned char)*lex->current))
-        {
             lex->current++;
-            lex->column++;
-        }
         type = FloatLiteral;
     }
 
-    return makeToken(type, start, *lex);
+    return makeToken(type, start, lex);
 }
 
 /**
@@ -197,7 +307,6 @@ static Token parseString(Lex *lex)
         if (*lex->current == '\\')
         {
             lex->current++;
-            lex->column++;
 
             switch (*lex->current)
             {
@@ -215,13 +324,9 @@ static Token parseString(Lex *lex)
                     tok.typ = Unknown;
                     tok.start = lex->current - 1;
                     tok.length = 1;
-                    tok.line = lex->line;
-                    tok.column = lex->column - 1;
+                    tok.loc = lex->base + (SourceLoc)(tok.start - lex->start);
 
-                    char msg[64];
-                    snprintf(msg, sizeof(msg),
-                             "Invalid escape sequence in string");
-                    reportError(LexicalError, msg, lex, &tok);
+                    lexError("Invalid escape sequence in string", lex, &tok);
                 }
                 break;
             }
@@ -229,27 +334,23 @@ static Token parseString(Lex *lex)
 
         if (*lex->current == '\n')
         {
-            Token tok = makeToken(Unknown, start, *lex);
-            reportError(LexicalError, "Unterminated string literal", lex, &tok);
+            Token tok = makeToken(Unknown, start, lex);
+            lexError("Unterminated string literal", lex, &tok);
             return tok;
         }
 
         if (*lex->current)
-        {
             lex->current++;
-            lex->column++;
-        }
     }
 
     if (*lex->current == '"')
     {
         lex->current++;
-        lex->column++;
-        return makeToken(StringLiteral, start, *lex);
+        return makeToken(StringLiteral, start, lex);
     }
 
-    Token tok = makeToken(Unknown, start, *lex);
-    reportError(LexicalError, "Unterminated string literal", lex, &tok);
+    Token tok = makeToken(Unknown, start, lex);
+    lexError("Unterminated string literal", lex, &tok);
     return tok;
 }
 
@@ -269,7 +370,6 @@ static Token parseChar(Lex *lex)
     if (*lex->current == '\\')
     {
         lex->current++;
-        lex->column++;
 
         switch (*lex->current)
         {
@@ -287,33 +387,25 @@ static Token parseChar(Lex *lex)
                 tok.typ = Unknown;
                 tok.start = lex->current - 1;
                 tok.length = 1;
-                tok.line = lex->line;
-                tok.column = lex->column - 1;
+                tok.loc = lex->base + (SourceLoc)(tok.start - lex->start);
 
-                char msg[64];
-                snprintf(msg, sizeof(msg),
-                         "Invalid escape sequence in char literal");
-                reportError(LexicalError, msg, lex, &tok);
+                lexError("Invalid escape sequence in char literal", lex, &tok);
             }
             break;
         }
     }
 
     if (*lex->current)
-    {
         lex->current++;
-        lex->column++;
-    }
 
     if (*lex->current == '\'')
     {
         lex->current++;
-        lex->column++;
-        return makeToken(CharLiteral, start - 1, *lex);
+        return makeToken(CharLiteral, start - 1, lex);
     }
 
-    Token tok = makeToken(Unknown, start, *lex);
-    reportError(LexicalError, "Unterminated char literal", lex, &tok);
+    Token tok = makeToken(Unknown, start, lex);
+    lexError("Unterminated char literal", lex, &tok);
     return tok;
 }
 
@@ -334,86 +426,81 @@ static Token parseSymbol(Lex *lex, char c)
     switch (c)
     {
     case '(':
-        return makeToken(LParen, start, *lex);
+        return makeToken(LParen, start, lex);
     case ')':
-        return makeToken(RParen, start, *lex);
+        return makeToken(RParen, start, lex);
     case '{':
-        return makeToken(LBrace, start, *lex);
+        return makeToken(LBrace, start, lex);
     case '}':
-        return makeToken(RBrace, start, *lex);
+        return makeToken(RBrace, start, lex);
     case '[':
-        return makeToken(LBracket, start, *lex);
+        return makeToken(LBracket, start, lex);
     case ']':
-        return makeToken(RBracket, start, *lex);
+        return makeToken(RBracket, start, lex);
     case '.':
-        return makeToken(Dot, start, *lex);
+        return makeToken(Dot, start, lex);
     case ';':
-        return makeToken(Semicolon, start, *lex);
+        return makeToken(Semicolon, start, lex);
     case ',':
-        return makeToken(Comma, start, *lex);
+        return makeToken(Comma, start, lex);
     case '%':
-        return makeToken(Percent, start, *lex);
+        return makeToken(Percent, start, lex);
     case '^':
-        return makeToken(Carot, start, *lex);
+        return makeToken(Carot, start, lex);
     case '+':
-        return makeToken(Plus, start, *lex);
+        return makeToken(Plus, start, lex);
     case '*':
-        return makeToken(Star, start, *lex);
+        return makeToken(Star, start, lex);
     case '/':
-        return makeToken(Slash, start, *lex);
+        return makeToken(Slash, start, lex);
     case '=':
-        return makeToken(Assign, start, *lex);
+        return makeToken(Assign, start, lex);
     case '>':
-        return makeToken(Greater, start, *lex);
+        return makeToken(Greater, start, lex);
     case '<':
         if (*lex->current == '>')
         {
             lex->current++;
-            lex->column++;
-            return makeToken(NotEqual, start, *lex);
+            return makeToken(NotEqual, start, lex);
         }
-        return makeToken(Less, start, *lex);
+        return makeToken(Less, start, lex);
     case ':':
         if (*lex->current == ':')
         {
             lex->current++;
-            lex->column++;
-            return makeToken(ConsOP, start, *lex);
+            return makeToken(ConsOP, start, lex);
         }
-        return makeToken(Colon, start, *lex);
+        return makeToken(Colon, start, lex);
     case '-':
         if (*lex->current == '>')
         {
             lex->current++;
-            lex->column++;
-            return makeToken(Arrow, start, *lex);
+            return makeToken(Arrow, start, lex);
         }
-        return makeToken(Minus, start, *lex);
+        return makeToken(Minus, start, lex);
     case '&':
         if (*lex->current == '&')
         {
             lex->current++;
-            lex->column++;
-            return makeToken(LogicalAnd, start, *lex);
+            return makeToken(LogicalAnd, start, lex);
         }
-        return makeToken(Ampersand, start, *lex);
+        return makeToken(Ampersand, start, lex);
     case '|':
         if (*lex->current == '|')
         {
             lex->current++;
-            lex->column++;
-            return makeToken(LogicalOr, start, *lex);
+            return makeToken(LogicalOr, start, lex);
         }
-        return makeToken(Pipe, start, *lex);
+        return makeToken(Pipe, start, lex);
     default:;
-        Token tok = makeToken(Unknown, start, *lex);
-        reportError(LexicalError, "Unknown symbol", lex, &tok);
+        Token tok = makeToken(Unknown, start, lex);
+        lexError("Unknown symbol", lex, &tok);
         return tok;
     }
 }
 
 /**
- * @brief Retrieves the next token from the source code.
+ * @brief Scans one token directly from the source code.
  *
  * Skips whitespace and comments, then determines the type of the next
  * token and delegates to the appropriate parsing function.
@@ -421,15 +508,14 @@ static Token parseSymbol(Lex *lex, char c)
  * @param lex Pointer to the lexer to advance.
  * @return Token The next token in the source code.
  */
-Token getNextToken(Lex *lex)
+static Token scanToken(Lex *lex)
 {
-    *lex = skipWhiteSpace(*lex);
+    skipWhiteSpace(lex);
 
     if (*lex->current == '\0')
-        return makeToken(Eof, lex->current, *lex);
+        return makeToken(Eof, lex->current, lex);
 
     char c = *lex->current++;
-    lex->column++;
 
     if (isalpha((unsigned char)c) || c == '_')
         return parseIdentifier(lex);
@@ -442,3 +528,100 @@ Token getNextToken(Lex *lex)
 
     return parseSymbol(lex, c);
 }
+
+/**
+ * @brief Scans one token into the next free slot of the ring.
+ *
+ * @param lex Pointer to the lexer to advance.
+ */
+static void fillSlot(Lex *lex)
+{
+    LexSlot *slot = &lex->ring[lex->tail & (LEX_LOOKAHEAD - 1)];
+    slot->current = lex->current;
+    slot->token = scanToken(lex);
+    lex->tail++;
+    if (lex->tail > lex->scanned)
+        lex->scanned = lex->tail;
+}
+
+/**
+ * @brief Retrieves the next token from the source code.
+ *
+ * Returns a buffered lookahead token if one is available, otherwise scans
+ * a new one.
+ *
+ * @param lex Pointer to the lexer to advance.
+ * @return Token The next token in the source code.
+ */
+Token getNextToken(Lex *lex)
+{
+    if (lex->head == lex->tail)
+        fillSlot(lex);
+    return lex->ring[lex->head++ & (LEX_LOOKAHEAD - 1)].token;
+}
+
+/**
+ * @brief Returns the token `n` positions past the next one without consuming it.
+ *
+ * @param lex Pointer to the lexer.
+ * @param n Lookahead distance; must be less than LEX_LOOKAHEAD.
+ * @return Token The requested lookahead token, or an empty Unknown token
+ *         if `n` is out of range.
+ */
+Token peekToken(Lex *lex, unsigned int n)
+{
+    if (n >= LEX_LOOKAHEAD)
+        return makeToken(Unknown, lex->current, lex);
+    while (lex->tail - lex->head <= n)
+        fillSlot(lex);
+    return lex->ring[(lex->head + n) & (LEX_LOOKAHEAD - 1)].token;
+}
+
+/**
+ * @brief Records the position of the next token to be returned.
+ *
+ * If lookahead is buffered, the scan position saved with the next buffered
+ * token is used, since the lexer itself has already moved past it.
+ *
+ * @param lex Pointer to the lexer.
+ * @return LexMark The checkpoint.
+ */
+LexMark lexMark(const Lex *lex)
+{
+    if (lex->head != lex->tail)
+    {
+        const LexSlot *slot = &lex->ring[lex->head & (LEX_LOOKAHEAD - 1)];
+        return (LexMark){
+            .current = slot->current,
+            .index = lex->head};
+    }
+
+    return (LexMark){
+        .current = lex->current,
+        .index = lex->head};
+}
+
+/**
+ * @brief Rewinds the lexer to a checkpoint.
+ *
+ * When every token from the mark onwards is still valid in the ring, only
+ * the read index moves. Otherwise the ring is discarded, its entries are
+ * marked stale by raising `floor`, and scanning restarts from the position
+ * saved in the mark.
+ *
+ * @param lex Pointer to the lexer.
+ * @param mark The checkpoint to return to.
+ */
+void lexRewind(Lex *lex, LexMark mark)
+{
+    if (mark.index >= lex->floor && lex->tail - mark.index <= LEX_LOOKAHEAD)
+    {
+        lex->head = mark.index;
+        return;
+    }
+
+    lex->current = mark.current;
+    lex->head = mark.index;
+    lex->tail = mark.index;
+    lex->floor = mark.index;
+}
@@ -0,0 +1,290 @@
+/**
+ * @file source.c
+ * @brief Implements the source manager for the Thale programming language.
+ *
+ * This file registers source files read from disk or supplied in memory,
+ * assigns each a contiguous range of the global location space, and builds
+ * the per-file line tables used to turn a location back into a line and
+ * column.
+ *
+ * @author Codezz-ops <codezz-ops@protonmail.com>
+ *
+ * @copyright Copyright (c) 2025 Codezz-ops
+ */
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "context.h"
+#include "source.h"
+
+/**
+ * @brief Initializes an empty source manager.
+ *
+ * @param sm Pointer to the source manager to initialize.
+ * @param ctx Pointer to the context whose allocator is used.
+ */
+void initSourceManager(SourceManager *sm, ThaleContext *ctx)
+{
+    sm->ctx = ctx;
+    sm->files = NULL;
+    sm->count = 0;
+    sm->capacity = 0;
+    sm->nextBase = 0;
+}
+
+/**
+ * @brief Releases a single file and everything it owns.
+ *
+ * @param ctx Pointer to the context that allocated the file.
+ * @param file The file to release.
+ */
+static void freeSourceFile(ThaleContext *ctx, SourceFile *file)
+{
+    contextFree(ctx, file->path);
+    contextFree(ctx, file->text);
+    contextFree(ctx, file->lines);
+    contextFree(ctx, file);
+}
+
+/**
+ * @brief Releases every file registered with the source manager.
+ *
+ * @param sm Pointer to the source manager.
+ */
+void freeSourceManager(SourceManager *sm)
+{
+    for (uint32_t i = 0; i < sm->count; i++)
+        freeSourceFile(sm->ctx, sm->files[i]);
+    contextFree(sm->ctx, sm->files);
+    initSourceManager(sm, sm->ctx);
+}
+
+/**
+ * @brief Builds the table of line-start offsets for a file.
+ *
+ * Counts the newlines first so the table is allocated exactly once.
+ *
+ * @param ctx Pointer to the context used for allocation.
+ * @param file The file whose text and length are already set.
+ * @return bool false if the table could not be allocated.
+ */
+static bool buildLineTable(ThaleContext *ctx, SourceFile *file)
+{
+    const char *text = file->text, *end = text + file->length;
+    uint32_t count = 1;
+    for (const char *p = text; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; p++)
+        count++;
+
+    file->lines = (uint32_t *)contextAlloc(ctx, count * sizeof(uint32_t));
+    if (file->lines == NULL)
+        return false;
+
+    file->lines[0] = 0;
+    file->lineCount = 1;
+    for (const char *p = text; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; p++)
+        file->lines[file->lineCount++] = (uint32_t)(p + 1 - text);
+    return true;
+}
+
+/**
+ * @brief Takes ownership of a NUL-terminated text buffer and registers it.
+ *
+ * Assigns the next range of the location space and appends the file to the
+ * manager, growing the file table when needed. On failure `text` is freed.
+ *
+ * @param sm Pointer to the source manager.
+ * @param name Name of the file; copied.
+ * @param text Buffer of `length` bytes plus a terminating NUL.
+ * @param length Length of the text.
+ * @return const SourceFile* The registered file, or NULL on failure.
+ */
+static const SourceFile *registerSource(SourceManager *sm, const char *name, char *text, size_t length)
+{
+    ThaleContext *ctx = sm->ctx;
+
+    if (length >= UINT32_MAX - sm->nextBase)
+    {
+        contextFree(ctx, text);
+        return NULL;
+    }
+
+    if (sm->count == sm->capacity)
+    {
+        uint32_t capacity = sm->capacity ? sm->capacity * 2 : 8;
+        SourceFile **files = (SourceFile **)contextAlloc(ctx, capacity * sizeof(SourceFile *));
+        if (files == NULL)
+        {
+            contextFree(ctx, text);
+            return NULL;
+        }
+        if (sm->count)
+            memcpy(files, sm->files, sm->count * sizeof(SourceFile *));
+        contextFree(ctx, sm->files);
+        sm->files = files;
+        sm->capacity = capacity;
+    }
+
+    SourceFile *file = (SourceFile *)contextAlloc(ctx, sizeof(SourceFile));
+    if (file == NULL)
+    {
+        contextFree(ctx, text);
+        return NULL;
+    }
+
+    size_t nameLength = strlen(name);
+    file->path = (char *)contextAlloc(ctx, nameLength + 1);
+    file->text = text;
+    file->base = sm->nextBase;
+    file->length = (uint32_t)length;
+    file->lines = NULL;
+    file->lineCount = 0;
+
+    if (file->path == NULL || !buildLineTable(ctx, file))
+    {
+        freeSourceFile(ctx, file);
+        return NULL;
+    }
+    memcpy(file->path, name, nameLength + 1);
+
+    sm->files[sm->count++] = file;
+    sm->nextBase += file->length + 1;
+    return file;
+}
+
+/**
+ * @brief Reads a file from disk and registers it.
+ *
+ * @param sm Pointer to the source manager.
+ * @param path Path of the file to read.
+ * @return const SourceFile* The registered file, or NULL on failure.
+ */
+const SourceFile *addSourceFile(SourceManager *sm, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return NULL;
+
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+        length = ftell(file);
+    rewind(file);
+
+    if (length < 0 || (unsigned long)length >= UINT32_MAX)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    char *text = (char *)contextAlloc(sm->ctx, (size_t)length + 1);
+    if (text == NULL)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    size_t bytesRead = fread(text, 1, (size_t)length, file);
+    fclose(file);
+    if (bytesRead != (size_t)length)
+    {
+        contextFree(sm->ctx, text);
+        return NULL;
+    }
+    text[length] = '\0';
+
+    return registerSource(sm, path, text, (size_t)length);
+}
+
+/**
+ * @brief Registers a copy of an in-memory buffer as a source file.
+ *
+ * @param sm Pointer to the source manager.
+ * @param name Name used for the file in diagnostics.
+ * @param text The source text.
+ * @param length Length of `text` in bytes.
+ * @return const SourceFile* The registered file, or NULL on failure.
+ */
+const SourceFile *addSourceBuffer(SourceManager *sm, const char *name, const char *text, size_t length)
+{
+    if (length >= UINT32_MAX)
+        return NULL;
+
+    char *copy = (char *)contextAlloc(sm->ctx, length + 1);
+    if (copy == NULL)
+        return NULL;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+
+    return registerSource(sm, name, copy, length);
+}
+
+/**
+ * @brief Finds the file that contains a location by binary search on file bases.
+ *
+ * @param sm Pointer to the source manager.
+ * @param loc The location to look up.
+ * @return const SourceFile* The containing file, or NULL if none.
+ */
+const SourceFile *findSourceFile(const SourceManager *sm, SourceLoc loc)
+{
+    uint32_t lo = 0, hi = sm->count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (sm->files[mid]->base <= loc)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0)
+        return NULL;
+
+    const SourceFile *file = sm->files[lo - 1];
+    return loc - file->base <= file->length ? file : NULL;
+}
+
+/**
+ * @brief Maps a location to a line and column by binary search on the line table.
+ *
+ * @param file The file containing `loc`.
+ * @param loc The location to resolve.
+ * @return SourcePosition The 1-based line and column of `loc`.
+ */
+SourcePosition resolveFileLocation(const SourceFile *file, SourceLoc loc)
+{
+    uint32_t offset = loc - file->base;
+    uint32_t lo = 0, hi = file->lineCount;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (file->lines[mid] <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return (SourcePosition){
+        .file = file,
+        .line = (int)lo,
+        .column = (int)(offset - file->lines[lo - 1]) + 1};
+}
+
+/**
+ * @brief Maps a location to its file, line and column.
+ *
+ * @param sm Pointer to the source manager.
+ * @param loc The location to resolve.
+ * @return SourcePosition The resolved position, with a NULL file if `loc`
+ *         is outside every registered file.
+ */
+SourcePosition resolveLocation(const SourceManager *sm, SourceLoc loc)
+{
+    const SourceFile *file = findSourceFile(sm, loc);
+    if (file == NULL)
+        return (SourcePosition){.file = NULL, .line = 0, .column = 0};
+    return resolveFileLocation(file, loc);
+}
@@ -15,6 +15,7 @@
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#include "context.h"
 #include "lex.h"
 #include "help.h"
 #include <string.h>
@@ -25,9 +26,11 @@
 /**
  * @brief The main entry point of the Thale compiler.
  *
- * This function processes command-line arguments, opens the input file,
- * reads its contents into memory, initializes the lexer, and retrieves
+ * This function processes command-line arguments, registers the input file
+ * with a source manager, initializes the lexer, and retrieves
  * tokens from the source code until the end of the file is reached.
+ * Lexical errors are reported as they are found and make the compiler
+ * exit with a failure status once the whole file has been scanned.
  *
  * @param argc The number of command-line arguments.
  * @param argv An array of command-line argument strings.
@@ -45,41 +48,22 @@ int main(int argc, char *argv[])
     if (dispatch != -1)
         return dispatch;
 
-    long length;
-    FILE *file;
-    char *buffer;
+    ThaleContext ctx;
+    SourceManager sources;
+    const SourceFile *file;
     Lex lex;
-    size_t bytesRead;
 
-    file = fopen(argv[1], "r");
-    if (file == NULL)
-    {
-        fputs("thale: error: could not read file.\n", stderr);
-        return EXIT_FAILURE;
-    }
-
-    fseek(file, 0, SEEK_END);
-    length = ftell(file);
-    rewind(file);
+    initContext(&ctx);
+    initSourceManager(&sources, &ctx);
 
-    buffer = (char *)malloc((size_t)(length + 1));
-    if (buffer == NULL)
-    {
-        fprintf(stderr, "thale: error: could not allocate memory for file '%s'\n", argv[1]);
-        return EXIT_FAILURE;
-    }
-
-    bytesRead = fread(buffer, 1, (size_t)(length), file);
-    if (bytesRead != (size_t)length)
+    file = addSourceFile(&sources, argv[1]);
+    if (file == NULL)
     {
         fprintf(stderr, "thale: error: could not read file '%s'\n", argv[1]);
-        free(buffer);
-        fclose(file);
         return EXIT_FAILURE;
     }
-    buffer[length] = '\0';
 
-    initLex(&lex, buffer);
+    initLexFile(&lex, &ctx, file);
 
     while (true)
     {
@@ -92,8 +76,7 @@ int main(int argc, char *argv[])
         printf("Token: %d\n", token.typ);
     }
 
-    fclose(file);
-    free(buffer);
+    freeSourceManager(&sources);
 
-    return EXIT_SUCCESS;
+    return ctx.errorCount > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -2,5 +2,13 @@
 #define LEXER_TESTS_H
 
 void test_identifier(void);
+void test_keyword_prefix(void);
+void test_peek(void);
+void test_rewind(void);
+void test_rewind_past_ring(void);
+void test_rewind_nested(void);
+void test_rewind_diagnostics(void);
+void test_error_recovery(void);
+void test_error_positions(void);
 
 #endif
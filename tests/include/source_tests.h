@@ -0,0 +1,10 @@
+#ifndef SOURCE_TESTS_H
+#define SOURCE_TESTS_H
+
+void test_buffer_ranges(void);
+void test_resolve_location(void);
+void test_lex_file_locations(void);
+void test_file_diagnostic(void);
+void test_read_file(void);
+
+#endif
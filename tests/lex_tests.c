@@ -3,8 +3,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "include/lex_tests.h"
+#include "../source/include/context.h"
 #include "../source/include/lex.h"
 
+static ThaleContext ctx;
+
 void test_identifier(void)
 {
     Lex lex;
@@ -15,7 +18,7 @@ void test_identifier(void)
     for (size_t i = 0; i < numIdentifiers; ++i)
     {
         const char *input = identifiers[i];
-        initLex(&lex, (char *)input);
+        initLex(&lex, &ctx, (char *)input);
         token = getNextToken(&lex);
 
         assert(token.typ == Identifier);
@@ -37,7 +40,7 @@ void test_number(void)
     for (size_t i = 0; i < numInputs; ++i)
     {
         const char *input = numbers[i];
-        initLex(&lex, (char *)input);
+        initLex(&lex, &ctx, (char *)input);
         token = getNextToken(&lex);
 
         assert(token.typ == expectedTokens[i]);
@@ -59,7 +62,7 @@ void test_operator(void)
     for (size_t i = 0; i < numOperators; ++i)
     {
         const char *input = inputs[i];
-        initLex(&lex, (char *)input);
+        initLex(&lex, &ctx, (char *)input);
         token = getNextToken(&lex);
 
         assert(token.typ == expectedTokens[i]);
@@ -71,7 +74,7 @@ void test_keyword(void)
 {
     Lex lex;
     Token token;
-    const char *keywords[] = {"Char", "False", "Float", "Int", "let", "List", "match", "True", "type", "Unit", "with", "String"};
+    const char *keywords[] = {"Char", "False", "Float", "Int", "let", "List", "match", "True", "type", "Unit", "with", "String", "effect"};
     TokenType expectedTokens[] = {Char,
                                   False,
                                   Float,
@@ -83,12 +86,13 @@ void test_keyword(void)
                                   Type,
                                   Unit,
                                   With,
-                                  String};
+                                  String,
+                                  Effect};
     size_t num = sizeof(keywords) / sizeof(keywords[0]);
 
     for (size_t i = 0; i < num; ++i)
     {
-        initLex(&lex, (char *)keywords[i]);
+        initLex(&lex, &ctx, (char *)keywords[i]);
         token = getNextToken(&lex);
         assert(token.typ == expectedTokens[i]);
         token = getNextToken(&lex);
@@ -96,6 +100,23 @@ void test_keyword(void)
     }
 }
 
+void test_keyword_prefix(void)
+{
+    Lex lex;
+    Token token;
+    const char *inputs[] = {"In", "Ints", "lets", "Lis", "Flat", "Fals", "Falsy", "matches", "Effect", "string", "type_", "With", "unit"};
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i)
+    {
+        initLex(&lex, &ctx, (char *)inputs[i]);
+        token = getNextToken(&lex);
+        assert(token.typ == Identifier);
+        assert(token.length == (int)strlen(inputs[i]));
+        token = getNextToken(&lex);
+        assert(token.typ == Eof);
+    }
+}
+
 void test_string(void)
 {
     Lex lex;
@@ -106,7 +127,7 @@ void test_string(void)
 
     for (size_t i = 0; i < numInputs; ++i)
     {
-        initLex(&lex, (char *)inputs[i]);
+        initLex(&lex, &ctx, (char *)inputs[i]);
         token = getNextToken(&lex);
         assert(token.typ == StringLiteral);
         assert(token.length >= 2);
@@ -123,7 +144,7 @@ void test_comment(void)
         "-- comment", "-- another comment with symbols!@#"};
     for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i)
     {
-        initLex(&lex, (char *)inputs[i]);
+        initLex(&lex, &ctx, (char *)inputs[i]);
         token = getNextToken(&lex);
         assert(token.typ == Eof);
     }
@@ -134,7 +155,7 @@ void test_mixed_sequence(void)
     Lex lex;
     Token token;
     const char *input = "let x = 42 + 3.14";
-    initLex(&lex, (char *)input);
+    initLex(&lex, &ctx, (char *)input);
 
     TokenType expected[] = {
         Let, Identifier, Assign, IntLiteral, Plus, FloatLiteral, Eof};
@@ -154,7 +175,7 @@ void test_char(void)
     const char *inputs[] = {"'a'", "'\\n'", "'\\t'", "'\\''", "'\\\\'"};
     for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i)
     {
-        initLex(&lex, (char *)inputs[i]);
+        initLex(&lex, &ctx, (char *)inputs[i]);
         token = getNextToken(&lex);
         assert(token.typ == CharLiteral);
         token = getNextToken(&lex);
@@ -162,15 +183,254 @@ void test_char(void)
     }
 }
 
+void test_peek(void)
+{
+    Lex lex;
+    Token token;
+    const char *input = "main : Effect ()";
+    initLex(&lex, &ctx, (char *)input);
+
+    token = peekToken(&lex, 2);
+    assert(token.start == input + 7);
+    token = peekToken(&lex, 0);
+    assert(token.typ == Identifier);
+    token = peekToken(&lex, 1);
+    assert(token.typ == Colon);
+    token = peekToken(&lex, 5);
+    assert(token.typ == Eof);
+    token = peekToken(&lex, LEX_LOOKAHEAD);
+    assert(token.typ == Unknown && token.length == 0);
+
+    TokenType expected[] = {Identifier, Colon, Identifier, LParen, RParen, Eof};
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+    {
+        token = getNextToken(&lex);
+        assert(token.typ == expected[i]);
+    }
+}
+
+void test_rewind(void)
+{
+    Lex lex;
+    Token token;
+    const char *input = "main : Effect ()";
+    initLex(&lex, &ctx, (char *)input);
+
+    token = getNextToken(&lex);
+    assert(token.typ == Identifier);
+
+    LexMark mark = lexMark(&lex);
+    token = getNextToken(&lex);
+    assert(token.typ == Colon);
+    token = getNextToken(&lex);
+    assert(token.typ == Identifier);
+    lexRewind(&lex, mark);
+
+    token = getNextToken(&lex);
+    assert(token.typ == Colon);
+    assert(token.start == input + 5);
+
+    token = peekToken(&lex, 1);
+    assert(token.typ == LParen);
+    mark = lexMark(&lex);
+    token = getNextToken(&lex);
+    assert(token.start == input + 7);
+    lexRewind(&lex, mark);
+    token = getNextToken(&lex);
+    assert(token.start == input + 7);
+}
+
+void test_rewind_past_ring(void)
+{
+    Lex lex;
+    Token token;
+    const char *input = "let x = a b c d e f g h i j k l m n o p q r s t u v w";
+    initLex(&lex, &ctx, (char *)input);
+
+    token = getNextToken(&lex);
+    assert(token.typ == Let);
+    LexMark mark = lexMark(&lex);
+    for (int i = 0; i < LEX_LOOKAHEAD * 2; ++i)
+        getNextToken(&lex);
+    lexRewind(&lex, mark);
+
+    token = getNextToken(&lex);
+    assert(token.typ == Identifier);
+    assert(token.start == input + 4);
+    assert(token.loc == 4);
+    token = getNextToken(&lex);
+    assert(token.typ == Assign);
+}
+
+void test_rewind_nested(void)
+{
+    Lex lex;
+    Token token;
+    const char *input = "let x = a b c d e f g h i j k l m n o p q r s t u v w";
+    initLex(&lex, &ctx, (char *)input);
+
+    LexMark outer = lexMark(&lex);
+    token = getNextToken(&lex);
+    assert(token.typ == Let);
+    LexMark inner = lexMark(&lex);
+    for (int i = 0; i < 20; ++i)
+        getNextToken(&lex);
+
+    lexRewind(&lex, inner);
+    lexRewind(&lex, outer);
+    token = getNextToken(&lex);
+    assert(token.typ == Let);
+    assert(token.loc == 0);
+
+    lexRewind(&lex, inner);
+    token = getNextToken(&lex);
+    assert(token.typ == Identifier);
+    assert(token.loc == 4);
+}
+
+static void countDiagnostic(void *userData, const Diagnostic *diagnostic)
+{
+    assert(diagnostic->type == LexicalError);
+    assert(diagnostic->position.file == NULL);
+    assert(diagnostic->position.line >= 1 && diagnostic->position.column >= 1);
+    (void)diagnostic;
+    ++*(int *)userData;
+}
+
+void test_error_recovery(void)
+{
+    Lex lex;
+    Token token;
+    ThaleContext errorCtx;
+    int reported = 0;
+    const char *input = "let s = \"open\nlet c = 'ab' $ x";
+
+    initContext(&errorCtx);
+    errorCtx.diagnostic = countDiagnostic;
+    errorCtx.diagnosticData = &reported;
+    bool ok = initLex(&lex, &errorCtx, (char *)input);
+    assert(ok);
+
+    TokenType expected[] = {Let, Identifier, Assign, Unknown, Let, Identifier, Assign, Unknown, Identifier, Unknown, Unknown, Identifier, Eof};
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+    {
+        token = getNextToken(&lex);
+        assert(token.typ == expected[i]);
+    }
+    assert(errorCtx.errorCount == 4);
+    assert(reported == 4);
+    ok = initLex(&lex, &errorCtx, NULL);
+    assert(!ok);
+    (void)ok;
+}
+
+void test_rewind_diagnostics(void)
+{
+    Lex lex;
+    Token token;
+    ThaleContext errorCtx;
+    int reported = 0;
+    const char *input = "let x = $ a b c d e f g h i j k l m n o p q r s t u v w";
+
+    initContext(&errorCtx);
+    errorCtx.diagnostic = countDiagnostic;
+    errorCtx.diagnosticData = &reported;
+    bool ok = initLex(&lex, &errorCtx, (char *)input);
+    assert(ok);
+
+    LexMark mark = lexMark(&lex);
+    for (int i = 0; i < 5; ++i)
+        getNextToken(&lex);
+    lexRewind(&lex, mark);
+    for (int i = 0; i < 5; ++i)
+        getNextToken(&lex);
+    assert(errorCtx.errorCount == 1);
+
+    for (int i = 0; i < LEX_LOOKAHEAD * 2; ++i)
+        getNextToken(&lex);
+    lexRewind(&lex, mark);
+    for (int i = 0; i < 3; ++i)
+        getNextToken(&lex);
+    token = getNextToken(&lex);
+    assert(token.typ == Unknown);
+    assert(errorCtx.errorCount == 1);
+    assert(reported == 1);
+    (void)ok;
+}
+
+typedef struct
+{
+    int count, lines[8], columns[8];
+    char excerpts[8][32];
+} ErrorLog;
+
+static void logDiagnostic(void *userData, const Diagnostic *diagnostic)
+{
+    ErrorLog *log = (ErrorLog *)userData;
+    if (log->count < 8)
+    {
+        log->lines[log->count] = diagnostic->position.line;
+        log->columns[log->count] = diagnostic->position.column;
+        snprintf(log->excerpts[log->count], sizeof(log->excerpts[0]), "%.*s", diagnostic->lineLength, diagnostic->lineStart);
+    }
+    log->count++;
+}
+
+void test_error_positions(void)
+{
+    Lex lex;
+    Token token;
+    ThaleContext errorCtx;
+    ErrorLog log = {0};
+    const char *input = "$ x\nlet a\n\nb $ c $\n  $";
+
+    initContext(&errorCtx);
+    errorCtx.diagnostic = logDiagnostic;
+    errorCtx.diagnosticData = &log;
+    initLex(&lex, &errorCtx, (char *)input);
+
+    LexMark mark = lexMark(&lex);
+    do
+        token = getNextToken(&lex);
+    while (token.typ != Eof);
+    lexRewind(&lex, mark);
+    do
+        token = getNextToken(&lex);
+    while (token.typ != Eof);
+
+    int lines[] = {1, 4, 4, 5}, columns[] = {1, 3, 7, 3};
+    const char *excerpts[] = {"$ x", "b $ c $", "b $ c $", "  $"};
+    assert(log.count == 4);
+    for (int i = 0; i < 4; ++i)
+    {
+        assert(log.lines[i] == lines[i]);
+        assert(log.columns[i] == columns[i]);
+        assert(strcmp(log.excerpts[i], excerpts[i]) == 0);
+    }
+    (void)lines;
+    (void)columns;
+    (void)excerpts;
+}
+
 int main(void)
 {
+    initContext(&ctx);
     test_identifier();
     test_operator();
     test_number();
     test_keyword();
+    test_keyword_prefix();
     test_string();
     test_comment();
     test_mixed_sequence();
     test_char();
+    test_peek();
+    test_rewind();
+    test_rewind_past_ring();
+    test_rewind_nested();
+    test_error_recovery();
+    test_rewind_diagnostics();
+    test_error_positions();
+    assert(ctx.errorCount == 0);
     return EXIT_SUCCESS;
 }
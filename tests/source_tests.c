@@ -0,0 +1,188 @@
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "include/source_tests.h"
+#include "../source/include/context.h"
+#include "../source/include/lex.h"
+
+static ThaleContext ctx;
+
+void test_buffer_ranges(void)
+{
+    SourceManager sm;
+    initSourceManager(&sm, &ctx);
+
+    const char *texts[] = {"let a = 1", "", "let b =\n 2\n", "x"};
+    const SourceFile *files[sizeof(texts) / sizeof(texts[0])];
+    for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i)
+    {
+        files[i] = addSourceBuffer(&sm, "buffer.thl", texts[i], strlen(texts[i]));
+        assert(files[i] != NULL);
+        assert(strcmp(files[i]->text, texts[i]) == 0);
+        assert(files[i]->length == strlen(texts[i]));
+        if (i > 0)
+            assert(files[i]->base == files[i - 1]->base + files[i - 1]->length + 1);
+    }
+
+    for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i)
+    {
+        assert(findSourceFile(&sm, files[i]->base) == files[i]);
+        assert(findSourceFile(&sm, files[i]->base + files[i]->length) == files[i]);
+    }
+    assert(findSourceFile(&sm, sm.nextBase) == NULL);
+    (void)files;
+
+    freeSourceManager(&sm);
+    assert(sm.count == 0);
+}
+
+void test_resolve_location(void)
+{
+    SourceManager sm;
+    initSourceManager(&sm, &ctx);
+
+    const SourceFile *first = addSourceBuffer(&sm, "first.thl", "main", 4);
+    const char *text = "effect Console { print }\n\nmain : Effect ()\n";
+    const SourceFile *second = addSourceBuffer(&sm, "second.thl", text, strlen(text));
+    assert(first && second);
+    assert(second->lineCount == 4);
+
+    SourcePosition pos = resolveLocation(&sm, first->base + 2);
+    assert(pos.file == first && pos.line == 1 && pos.column == 3);
+
+    pos = resolveLocation(&sm, second->base);
+    assert(pos.file == second && pos.line == 1 && pos.column == 1);
+
+    pos = resolveLocation(&sm, second->base + 25);
+    assert(pos.file == second && pos.line == 2 && pos.column == 1);
+
+    pos = resolveLocation(&sm, second->base + (SourceLoc)(strstr(text, "Effect") - text));
+    assert(pos.file == second && pos.line == 3 && pos.column == 8);
+
+    pos = resolveLocation(&sm, second->base + second->length);
+    assert(pos.file == second && pos.line == 4 && pos.column == 1);
+
+    pos = resolveLocation(&sm, sm.nextBase + 10);
+    assert(pos.file == NULL);
+    (void)pos;
+
+    freeSourceManager(&sm);
+}
+
+void test_lex_file_locations(void)
+{
+    SourceManager sm;
+    Lex lex;
+    Token token;
+    initSourceManager(&sm, &ctx);
+
+    addSourceBuffer(&sm, "padding.thl", "let x = 1\n", 10);
+    const SourceFile *file = addSourceBuffer(&sm, "main.thl", "main\n  -> x", 11);
+    initLexFile(&lex, &ctx, file);
+
+    token = getNextToken(&lex);
+    assert(token.typ == Identifier && token.loc == file->base);
+
+    token = getNextToken(&lex);
+    assert(token.typ == Arrow);
+    SourcePosition pos = resolveLocation(&sm, token.loc);
+    assert(pos.file == file && pos.line == 2 && pos.column == 3);
+    (void)pos;
+
+    token = getNextToken(&lex);
+    token = getNextToken(&lex);
+    assert(token.typ == Eof && token.loc == file->base + file->length);
+
+    freeSourceManager(&sm);
+}
+
+typedef struct
+{
+    Diagnostic diagnostic;
+    char message[64], line[64];
+} CapturedDiagnostic;
+
+static void captureDiagnostic(void *userData, const Diagnostic *diagnostic)
+{
+    CapturedDiagnostic *captured = (CapturedDiagnostic *)userData;
+    captured->diagnostic = *diagnostic;
+    snprintf(captured->message, sizeof(captured->message), "%s", diagnostic->message);
+    snprintf(captured->line, sizeof(captured->line), "%.*s", diagnostic->lineLength, diagnostic->lineStart);
+    captured->diagnostic.message = captured->message;
+    captured->diagnostic.lineStart = captured->line;
+}
+
+void test_file_diagnostic(void)
+{
+    SourceManager sm;
+    Lex lex;
+    Token token;
+    ThaleContext errorCtx;
+    CapturedDiagnostic last;
+
+    initContext(&errorCtx);
+    errorCtx.diagnostic = captureDiagnostic;
+    errorCtx.diagnosticData = &last;
+    initSourceManager(&sm, &errorCtx);
+
+    addSourceBuffer(&sm, "padding.thl", "x\n", 2);
+    const SourceFile *file = addSourceBuffer(&sm, "bad.thl", "let a = 1\nlet b = $ 2\n", 22);
+    initLexFile(&lex, &errorCtx, file);
+    do
+        token = getNextToken(&lex);
+    while (token.typ != Eof);
+
+    assert(errorCtx.errorCount == 1);
+    assert(last.diagnostic.type == LexicalError);
+    assert(last.diagnostic.loc == file->base + 18);
+    assert(last.diagnostic.position.file == file);
+    assert(last.diagnostic.position.line == 2 && last.diagnostic.position.column == 9);
+    assert(strcmp(last.message, "Unknown symbol") == 0);
+    assert(last.diagnostic.lineLength == 11 && strcmp(last.line, "let b = $ 2") == 0);
+
+    freeSourceManager(&sm);
+}
+
+void test_read_file(void)
+{
+    SourceManager sm;
+    initSourceManager(&sm, &ctx);
+
+    const char *path = "source_tests.tmp";
+    const char *text = "let a = 1\r\nlet b = 2\n";
+    FILE *out = fopen(path, "wb");
+    assert(out != NULL);
+    fputs(text, out);
+    fclose(out);
+
+    const SourceFile *file = addSourceFile(&sm, path);
+    remove(path);
+    assert(file != NULL);
+    assert(strcmp(file->path, path) == 0);
+    assert(strcmp(file->text, text) == 0);
+    assert(file->lineCount == 3);
+    (void)file;
+
+    const SourceFile *missing = addSourceFile(&sm, "does/not/exist.thl");
+    assert(missing == NULL);
+    assert(sm.count == 1);
+    (void)missing;
+
+    freeSourceManager(&sm);
+}
+
+int main(void)
+{
+    initContext(&ctx);
+    test_buffer_ranges();
+    test_resolve_location();
+    test_lex_file_locations();
+    test_file_diagnostic();
+    test_read_file();
+    return EXIT_SUCCESS;
+}